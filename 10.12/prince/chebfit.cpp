@@ -0,0 +1,511 @@
+/* chebfit.cpp - Chebyshev economized or Remez minimax polynomial
+** fits for the math kernels.
+**
+** Does the job of listing1.bc without hand editing.  Name the
+** function, the interval, the degree and the precision the kernel
+** will run in; the output is a constexpr coefficient table plus
+** Horner and Estrin evaluation code, ready to #include.
+**
+**    chebfit [-remez] [-float|-double|-long] [-name id] [-tol e]
+**            func a b [degree]
+**
+** func is sin, cos, atan or exp.  As in listing1.bc the fit is
+** made to a reduced function so that the leading term(s) stay
+** exact and the last operation is the addition of a larger
+** quantity:
+**
+**    sin(x)  = x + x*x2 * P(x2)        x2 = x*x
+**    cos(x)  = 1 + x2 * P(x2)
+**    atan(x) = x - x*x2 * P(x2)
+**    exp(x)  = 1 + (x + x*x * P(x))
+**
+** -remez fits the minimax relative error; the default is the
+** Chebyshev economization of listing1.bc (chebft, chebpc and
+** pcshft from Press, Flannery et al).  degree is the degree of
+** P; when it is left out, the smallest degree whose relative
+** error, with coefficients rounded to the target type, is below
+** -tol (half an ulp of the target type by default) is used; if
+** none up to 30 is, chebfit says so and exits with status 1.
+**
+** All arithmetic is long double; that is enough for float and
+** double kernels, marginal for long double ones.
+**
+** e.g.  chebfit -remez -float sin -.7853981634 .7853981634
+*/
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+typedef long double real;
+typedef std::vector<real> rvec;
+
+static const real pi = 3.14159265358979323846264338327950288L;
+
+/* Reduced functions g(t), fitted by P(t).
+** For the even and odd functions t = x*x.  Near 0 the closed forms
+** cancel badly, so the Taylor series is summed instead. */
+static real series(real t, real (*term)(int))
+{
+    real s = 0, p = 1;
+    for (int k = 0; k < 200; ++k, p *= t) {
+        real d = p * term(k);
+        s += d;
+        if (fabsl(d) <= fabsl(s) * 1e-30L)
+            break;
+    }
+    return s;
+}
+
+static real fact(int n)
+{
+    real f = 1;
+    while (n > 1)
+        f *= n--;
+    return f;
+}
+
+static real sin_term(int k) { return (k & 1 ? 1 : -1) / fact(2 * k + 3); }
+static real cos_term(int k) { return (k & 1 ? 1 : -1) / fact(2 * k + 2); }
+static real atan_term(int k) { return (k & 1 ? -1 : 1) / (real) (2 * k + 3); }
+static real exp_term(int k) { return 1 / fact(k + 2); }
+
+static real sin_g(real t)
+{
+    real x = sqrtl(t);
+    return t < .25L ? series(t, sin_term) : (sinl(x) / x - 1) / t;
+}
+static real sin_f(real x) { return sinl(x); }
+static real sin_a(real x, real p) { return x + x * (x * x) * p; }
+
+static real cos_g(real t)
+{
+    return t < .25L ? series(t, cos_term) : (cosl(sqrtl(t)) - 1) / t;
+}
+static real cos_f(real x) { return cosl(x); }
+static real cos_a(real x, real p) { return 1 + (x * x) * p; }
+
+static real atan_g(real t)
+{
+    real x = sqrtl(t);
+    return t < .25L ? series(t, atan_term) : (1 - atanl(x) / x) / t;
+}
+static real atan_f(real x) { return atanl(x); }
+static real atan_a(real x, real p) { return x - x * (x * x) * p; }
+
+static real exp_g(real x)
+{
+    return fabsl(x) < .25L ? series(x, exp_term) :
+        (expl(x) - 1 - x) / (x * x);
+}
+static real exp_f(real x) { return expl(x); }
+static real exp_a(real x, real p) { return 1 + (x + x * x * p); }
+
+struct fitfun {
+    const char *name;
+    bool even;                  /* fit in t = x*x */
+    real (*g)(real);            /* reduced function, fitted by P */
+    real (*f)(real);            /* the function itself */
+    real (*assemble)(real x, real p);   /* f(x) from P(t) */
+    const char *result;         /* code for the same, p = P(t) */
+};
+
+static const fitfun funs[] = {
+    {"sin", true, sin_g, sin_f, sin_a, "x + x * x2 * p"},
+    {"cos", true, cos_g, cos_f, cos_a, "1 + x2 * p"},
+    {"atan", true, atan_g, atan_f, atan_a, "x - x * x2 * p"},
+    {"exp", false, exp_g, exp_f, exp_a, "1 + (x + x * x * p)"},
+};
+
+/* Target precision */
+struct target {
+    const char *type;
+    const char *suffix;
+    int digits;
+    real eps;
+    real (*round)(real);
+};
+
+static real round_f(real v) { return (float) v; }
+static real round_d(real v) { return (double) v; }
+static real round_l(real v) { return v; }
+
+static const target targets[] = {
+    {"float", "f", FLT_DECIMAL_DIG, FLT_EPSILON, round_f},
+    {"double", "", DBL_DECIMAL_DIG, DBL_EPSILON, round_d},
+    {"long double", "L", LDBL_DECIMAL_DIG, LDBL_EPSILON, round_l},
+};
+
+/* One fit: P(t) = sum c[j] t^j on [ta, tb] */
+struct fit {
+    const fitfun *fn;
+    real xa, xb;                /* interval in x */
+    real ta, tb;                /* interval in t */
+    rvec c;                     /* power basis coefficients */
+};
+
+static real t_of(const fit & F, real x)
+{
+    return F.fn->even ? x * x : x;
+}
+
+static real poly(const rvec & c, real t)
+{
+    real p = 0;
+    for (size_t j = c.size(); j-- > 0;)
+        p = p * t + c[j];
+    return p;
+}
+
+/* Chebyshev series on [ta, tb] to power series in t:
+** chebpc and pcshft, as in listing1.bc */
+static rvec cheb_to_power(const rvec & c, real a, real b)
+{
+    int n = (int) c.size();
+    rvec d(n, 0), e(n, 0);
+    d[0] = c[n - 1];
+    for (int j = n - 2; j >= 1; --j) {
+        for (int k = n - j; k >= 1; --k) {
+            real s = e[k];
+            e[k] = d[k];
+            d[k] = 2 * d[k - 1] - s;
+        }
+        real s = e[0];
+        e[0] = d[0];
+        d[0] = -s + c[j];
+    }
+    for (int j = n - 1; j >= 1; --j)
+        d[j] = d[j - 1] - e[j];
+    d[0] = -e[0] + c[0] / 2;
+
+    real g = 2 / (b - a);
+    for (int j = 1; j < n; ++j, g *= 2 / (b - a))
+        d[j] *= g;
+    for (int j = 0; j < n - 1; ++j)
+        for (int k = n - 2; k >= j; --k)
+            d[k] -= (a + b) / 2 * d[k + 1];
+    return d;
+}
+
+/* chebft: Chebyshev coefficients of g on [a, b], c[0] doubled */
+static rvec chebft(real (*g)(real), real a, real b, int n)
+{
+    rvec f(n), c(n);
+    for (int k = 0; k < n; ++k)
+        f[k] = g(cosl(pi * (k + .5L) / n) * (b - a) / 2 + (b + a) / 2);
+    for (int j = 0; j < n; ++j) {
+        real s = 0;
+        for (int k = 0; k < n; ++k)
+            s += cosl(pi * j * (k + .5L) / n) * f[k];
+        c[j] = 2 * s / n;
+    }
+    return c;
+}
+
+static void chebyshev(fit & F, int degree)
+{
+    /* several more terms than are kept, as listing1.bc advises */
+    rvec c = chebft(F.fn->g, F.ta, F.tb, degree + 12);
+    c.resize(degree + 1);
+    F.c = cheb_to_power(c, F.ta, F.tb);
+}
+
+/* Relative error of the assembled function at x for coefficients c */
+static real relerr(const fit & F, const rvec & c, real x)
+{
+    real f = F.fn->f(x);
+    if (f == 0)
+        return 0;
+    return (F.fn->assemble(x, poly(c, t_of(F, x))) - f) / f;
+}
+
+/* Same, as a function of t, with the sign of x taken from the
+** interval for the even functions */
+static real relerr_t(const fit & F, const rvec & c, real t)
+{
+    if (!F.fn->even)
+        return relerr(F, c, t);
+    real x = sqrtl(t);
+    return relerr(F, c, F.xb > 0 ? x : -x);
+}
+
+/* Maximum relative error of exact coefficients c, over t */
+static real maxerr_exact(const fit & F, const rvec & c)
+{
+    real e = 0;
+    const int grid = 4000;
+    for (int k = 0; k <= grid; ++k)
+        e = fmaxl(e, fabsl(relerr_t(F, c,
+                    F.ta + (F.tb - F.ta) * k / grid)));
+    return e;
+}
+
+/* Gaussian elimination with partial pivoting; a is n by n+1 */
+static bool solve(std::vector<rvec> & a, rvec & x)
+{
+    int n = (int) a.size();
+    for (int i = 0; i < n; ++i) {
+        int p = i;
+        for (int r = i + 1; r < n; ++r)
+            if (fabsl(a[r][i]) > fabsl(a[p][i]))
+                p = r;
+        if (a[p][i] == 0)
+            return false;
+        std::swap(a[i], a[p]);
+        for (int r = i + 1; r < n; ++r) {
+            real m = a[r][i] / a[i][i];
+            for (int k = i; k <= n; ++k)
+                a[r][k] -= m * a[i][k];
+        }
+    }
+    x.assign(n, 0);
+    for (int i = n; i-- > 0;) {
+        real s = a[i][n];
+        for (int k = i + 1; k < n; ++k)
+            s -= a[i][k] * x[k];
+        x[i] = s / a[i][i];
+    }
+    return true;
+}
+
+/* Remez exchange on the weighted error w(t) (P(t) - g(t)), w being
+** the sensitivity of the relative error of f to P.  Starts from the
+** Chebyshev fit.  Where w vanishes inside the interval (x = 0 for
+** exp) the fitting space is not a Haar space and the exchange may
+** wander, so the best coefficients seen are the ones kept. */
+static void remez(fit & F, int degree)
+{
+    int n = degree + 1, m = n + 1;
+    real ta = F.ta, tb = F.tb;
+    rvec t(m), sol;
+
+    /* Chebyshev extrema, skipping ta where the weight may vanish */
+    for (int i = 0; i < m; ++i)
+        t[i] = ta + (tb - ta) * (1 - cosl(pi * (i + 1) / m)) / 2;
+
+    chebyshev(F, degree);
+    rvec best_c = F.c;
+    real best = HUGE_VALL;
+    for (int iter = 0; iter < 40; ++iter) {
+        std::vector<rvec> a(m, rvec(m + 1));
+        for (int i = 0; i < m; ++i) {
+            real x = F.fn->even ? sqrtl(t[i]) : t[i];
+            if (F.fn->even && F.xb <= 0)
+                x = -x;
+            /* d relerr / d P at t[i] */
+            real w = (F.fn->assemble(x, 1) - F.fn->assemble(x, 0)) /
+                F.fn->f(x);
+            real p = 1;
+            for (int j = 0; j < n; ++j, p *= t[i])
+                a[i][j] = w * p;
+            a[i][n] = i & 1 ? -1 : 1;
+            a[i][m] = w * F.fn->g(t[i]);
+        }
+        if (!solve(a, sol))
+            break;
+        rvec c(sol.begin(), sol.begin() + n);
+
+        /* Locate the extrema of the error on a fine grid */
+        const int grid = 400 * m;
+        std::vector<real> ext_t, ext_e;
+        real best_t = ta, best_e = relerr_t(F, c, ta);
+        real top = fabsl(best_e);
+        for (int k = 1; k <= grid; ++k) {
+            real tk = ta + (tb - ta) * k / grid;
+            real ek = relerr_t(F, c, tk);
+            top = fmaxl(top, fabsl(ek));
+            if ((ek < 0) != (best_e < 0) && ek != 0 && best_e != 0) {
+                ext_t.push_back(best_t);
+                ext_e.push_back(best_e);
+                best_t = tk, best_e = ek;
+            } else if (fabsl(ek) > fabsl(best_e))
+                best_t = tk, best_e = ek;
+        }
+        ext_t.push_back(best_t);
+        ext_e.push_back(best_e);
+
+        /* Keep m alternating extrema, dropping the smaller end */
+        while ((int) ext_t.size() > m) {
+            if (fabsl(ext_e.front()) < fabsl(ext_e.back()))
+                ext_t.erase(ext_t.begin()), ext_e.erase(ext_e.begin());
+            else
+                ext_t.pop_back(), ext_e.pop_back();
+        }
+        if (top < best)
+            best = top, best_c = c;
+        real lo = HUGE_VALL, hi = 0;
+        for (real e : ext_e)
+            lo = fminl(lo, fabsl(e)), hi = fmaxl(hi, fabsl(e));
+        if ((int) ext_t.size() < m)
+            break;              /* lost the alternation; keep what we have */
+        t = ext_t;
+        if (hi - lo <= hi * 1e-4L)
+            break;
+    }
+    if (best < maxerr_exact(F, F.c))
+        F.c = best_c;
+}
+
+/* Maximum relative error with coefficients rounded to the target */
+static real maxerr(const fit & F, const target & T, rvec * rounded)
+{
+    rvec c(F.c);
+    for (real & v : c)
+        v = T.round(v);
+    real e = 0;
+    const int grid = 20000;
+    for (int k = 0; k <= grid; ++k)
+        e = fmaxl(e, fabsl(relerr(F, c,
+                    F.xa + (F.xb - F.xa) * k / grid)));
+    if (rounded)
+        *rounded = c;
+    return e;
+}
+
+/* Name of t^h in the generated code: t is x, or x2 for the
+** even and odd functions */
+static std::string power(const fit & F, int h)
+{
+    if (F.fn->even)
+        h *= 2;
+    return h == 1 ? "x" : "x" + std::to_string(h);
+}
+
+/* Estrin's scheme over c[lo..lo+n-1] in powers t, t^2, t^4, ... */
+static std::string estrin(const fit & F, const std::string & id,
+    int lo, int n)
+{
+    if (n == 1)
+        return id + "[" + std::to_string(lo) + "]";
+    int h = 1;
+    while (2 * h < n)
+        h *= 2;
+    return "(" + estrin(F, id, lo, h) + " + " + power(F, h) + " * " +
+        estrin(F, id, lo + h, n - h) + ")";
+}
+
+static void emit(const fit & F, const target & T, const rvec & c,
+    real err, bool minimax, const char *id, real xa, real xb)
+{
+    int n = (int) c.size();
+    const char *ty = T.type;
+    std::string t = power(F, 1), coef = std::string(id) + "_coef";
+
+    printf("/* %s(x), %.10Lg <= x <= %.10Lg, %s degree %d in %s, %s\n",
+        F.fn->name, xa, xb, minimax ? "Remez minimax" :
+        "Chebyshev economized", n - 1, F.fn->even ? "x*x" : "x", ty);
+    printf(" * max relative error %.3Lg (%.3Lg ulp) before "
+        "evaluation roundoff\n * generated by chebfit */\n",
+        err, err / T.eps);
+    printf("constexpr %s %s[] = {\n", ty, coef.c_str());
+    for (int j = 0; j < n; ++j)
+        printf("    %.*Le%s,\n", T.digits - 1, c[j], T.suffix);
+    printf("};\n\n");
+
+    /* Horner */
+    printf("inline %s %s_horner(%s x)\n{\n", ty, id, ty);
+    if (F.fn->even)
+        printf("    %s x2 = x * x;\n", ty);
+    printf("    %s p = %s[%d];\n", ty, coef.c_str(), n - 1);
+    for (int j = n - 2; j >= 0; --j)
+        printf("    p = p * %s + %s[%d];\n", t.c_str(), coef.c_str(), j);
+    printf("    return %s;\n}\n\n", F.fn->result);
+
+    /* Estrin */
+    printf("inline %s %s_estrin(%s x)\n{\n", ty, id, ty);
+    if (F.fn->even)
+        printf("    %s x2 = x * x;\n", ty);
+    for (int h = 2; h < n; h *= 2)
+        printf("    %s %s = %s * %s;\n", ty, power(F, h).c_str(),
+            power(F, h / 2).c_str(), power(F, h / 2).c_str());
+    printf("    %s p = %s;\n", ty, estrin(F, coef, 0, n).c_str());
+    printf("    return %s;\n}\n", F.fn->result);
+}
+
+static int usage()
+{
+    fprintf(stderr, "usage: chebfit [-remez] [-float|-double|-long] "
+        "[-name id] [-tol e] func a b [degree]\n"
+        "       func: sin cos atan exp\n");
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    bool minimax = false;
+    const target *T = &targets[1];
+    const char *id = 0;
+    real tol = 0;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && isalpha(argv[i][1]); ++i) {
+        if (!strcmp(argv[i], "-remez"))
+            minimax = true;
+        else if (!strcmp(argv[i], "-float"))
+            T = &targets[0];
+        else if (!strcmp(argv[i], "-double"))
+            T = &targets[1];
+        else if (!strcmp(argv[i], "-long"))
+            T = &targets[2];
+        else if (!strcmp(argv[i], "-name") && i + 1 < argc)
+            id = argv[++i];
+        else if (!strcmp(argv[i], "-tol") && i + 1 < argc)
+            tol = strtold(argv[++i], 0);
+        else
+            return usage();
+    }
+    if (argc - i < 3)
+        return usage();
+
+    fit F;
+    F.fn = 0;
+    for (const fitfun & f : funs)
+        if (!strcmp(argv[i], f.name))
+            F.fn = &f;
+    if (!F.fn)
+        return usage();
+    F.xa = strtold(argv[i + 1], 0);
+    F.xb = strtold(argv[i + 2], 0);
+    int degree = argc - i > 3 ? atoi(argv[i + 3]) : 0;
+    if (!(F.xa < F.xb) || degree < 0 || degree > 30)
+        return usage();
+    if (!id)
+        id = F.fn->name;
+    real xa = F.xa, xb = F.xb;
+    if (tol <= 0)
+        tol = T->eps / 2;
+
+    if (F.fn->even) {
+        /* symmetric: fit one side only */
+        real lo = fabsl(F.xa), hi = fabsl(F.xb);
+        F.ta = F.xa < 0 && 0 < F.xb ? 0 : fminl(lo, hi) * fminl(lo, hi);
+        F.tb = fmaxl(lo, hi) * fmaxl(lo, hi);
+        if (F.xa < 0 && 0 < F.xb)
+            F.xa = 0, F.xb = fmaxl(lo, hi);
+    } else
+        F.ta = F.xa, F.tb = F.xb;
+
+    rvec c;
+    real err = 0;
+    for (int d = degree ? degree : 1; d <= (degree ? degree : 30); ++d) {
+        if (minimax)
+            remez(F, d);
+        else
+            chebyshev(F, d);
+        err = maxerr(F, *T, &c);
+        if (degree || err <= tol)
+            break;
+    }
+    if (!degree && err > tol) {
+        fprintf(stderr, "chebfit: %s: no degree up to 30 reaches %.3Lg "
+            "(best %.3Lg, %.3Lg ulp)\n", F.fn->name, tol, err,
+            err / T->eps);
+        return 1;
+    }
+    emit(F, *T, c, err, minimax, id, xa, xb);
+    return 0;
+}
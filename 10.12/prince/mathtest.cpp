@@ -0,0 +1,357 @@
+/* mathtest.cpp - accuracy and speed of the math kernels
+**
+** Sweeps each kernel over dense and random argument sets, and over
+** the awkward ones: arguments past HUGE_RAD, subnormal arguments and
+** results.  Every result is compared with a long double reference
+** (MPFR at 128 bits if built with -DUSE_MPFR -lmpfr) and the error
+** is counted in ulps of the kernel's own precision.  Each kernel is
+** then timed over an array of arguments; the float kernels are timed
+** both through their array forms and through a loop the compiler is
+** told not to vectorize, which gives the vector speedup.
+**
+** Listings 3 to 5 are pieces of Plauger's Standard C library and do
+** not build alone: they need its xmath.h on the include path, its
+** _Dscale and _Dtest to link, and listing5.c a logt().  The last line
+** of listing4.c, "WRAP_EOF", is left over from the archive and must
+** be deleted.  With those in place, compile the C files as C:
+**    cc -O2 -c listing3.c listing4.c listing5.c listing6.c sinred.c
+**    c++ -O2 -fopenmp-simd -fno-trapping-math -mavx2 -mfma mathtest.cpp
+**        listing3.o listing4.o listing5.o listing6.o sinred.o -lm
+**
+** Times are ns per call, and on x86 time stamp counter ticks per
+** call.  A set with a limit fails the run when its max error is past
+** it; sets with a limit of 0 are only reported.
+*/
+#include "fkernel.h"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#ifdef USE_MPFR
+#include <mpfr.h>
+#endif
+
+extern "C" {
+    double _Sin(double, unsigned int);  /* listing3.c */
+    int _Exp(double *, int);    /* listing4.c */
+    double pow(double, double); /* listing5.c */
+    double atan2(double, double);       /* listing6.c */
+}
+
+typedef long double real;
+
+/* References */
+#ifdef USE_MPFR
+static real mp_call(int (*f1)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t),
+    int (*f2)(mpfr_ptr, mpfr_srcptr, mpfr_srcptr, mpfr_rnd_t),
+    real x, real y)
+{
+    mpfr_t a, b, r;
+    mpfr_inits2(128, a, b, r, (mpfr_ptr) 0);
+    mpfr_set_ld(a, x, MPFR_RNDN);
+    mpfr_set_ld(b, y, MPFR_RNDN);
+    if (f1)
+        f1(r, a, MPFR_RNDN);
+    else
+        f2(r, a, b, MPFR_RNDN);
+    real v = mpfr_get_ld(r, MPFR_RNDN);
+    mpfr_clears(a, b, r, (mpfr_ptr) 0);
+    return v;
+}
+
+static real ref_sin(real x, real) { return mp_call(mpfr_sin, 0, x, 0); }
+static real ref_cos(real x, real) { return mp_call(mpfr_cos, 0, x, 0); }
+static real ref_exp(real x, real) { return mp_call(mpfr_exp, 0, x, 0); }
+static real ref_pow(real x, real y) { return mp_call(0, mpfr_pow, x, y); }
+static real ref_atan2(real y, real x)
+{
+    return mp_call(0, mpfr_atan2, y, x);
+}
+#else
+static real ref_sin(real x, real) { return sinl(x); }
+static real ref_cos(real x, real) { return cosl(x); }
+static real ref_exp(real x, real) { return expl(x); }
+static real ref_pow(real x, real y) { return powl(x, y); }
+static real ref_atan2(real y, real x) { return atan2l(y, x); }
+#endif
+
+/* Kernels, all called as f(x, y) */
+static double k_sin(double x, double) { return _Sin(x, 0); }
+static double k_cos(double x, double) { return _Sin(x, 1); }
+static double k_exp(double x, double)
+{
+    _Exp(&x, 0);
+    return x;
+}
+static double k_pow(double x, double y) { return pow(x, y); }
+static double k_atan2(double y, double x) { return atan2(y, x); }
+static double k_sinf(double x, double) { return _Sinf((float) x, 0); }
+static double k_cosf(double x, double) { return _Sinf((float) x, 1); }
+static double k_expf(double x, double) { return _Expf((float) x); }
+static double k_atan2f(double y, double x)
+{
+    return _Atan2f((float) y, (float) x);
+}
+
+/* Array forms of the float kernels, and the same loops kept scalar */
+typedef void vecfn(float *, const float *, const float *, std::size_t);
+
+static void v_sinf(float *r, const float *x, const float *, std::size_t n)
+{
+    _Vsinf(r, x, n);
+}
+static void v_cosf(float *r, const float *x, const float *, std::size_t n)
+{
+    _Vsinf(r, x, n, 1);
+}
+static void v_expf(float *r, const float *x, const float *, std::size_t n)
+{
+    _Vexpf(r, x, n);
+}
+static void v_atan2f(float *r, const float *y, const float *x,
+    std::size_t n)
+{
+    _Vatan2f(r, y, x, n);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define SCALAR __attribute__((optimize("no-tree-vectorize")))
+#else
+#define SCALAR
+#endif
+
+SCALAR static void s_sinf(float *r, const float *x, const float *,
+    std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] = _Sinf(x[i], 0);
+}
+SCALAR static void s_cosf(float *r, const float *x, const float *,
+    std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] = _Sinf(x[i], 1);
+}
+SCALAR static void s_expf(float *r, const float *x, const float *,
+    std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] = _Expf(x[i]);
+}
+SCALAR static void s_atan2f(float *r, const float *y, const float *x,
+    std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] = _Atan2f(y[i], x[i]);
+}
+
+/* Argument sets: a dense even sweep of x, uniform, or log-uniform
+** in magnitude, positive or with random sign */
+enum spread { DENSE, UNIFORM, LOGMAG, LOGSIGN };
+
+struct argset {
+    const char *name;
+    spread how;
+    double xlo, xhi, ylo, yhi;
+    double limit;               /* max ulps, 0 to only report */
+};
+
+struct kernel {
+    const char *name;
+    bool single;
+    double (*f)(double, double);
+    real (*ref)(real, real);
+    vecfn *vec, *scalar;
+    std::vector<argset> sets;
+};
+
+static const double pi = 3.14159265358979323846;
+
+static std::vector<kernel> kernels()
+{
+    const double tiny = DBL_TRUE_MIN, dmin = DBL_MIN;
+    const double ftiny = FLT_TRUE_MIN, fmin = FLT_MIN;
+    return {
+        {"_Sin", false, k_sin, ref_sin, 0, 0, {
+                {"dense", DENSE, -pi, pi, 0, 0, 2},
+                {"random", UNIFORM, -1e5, 1e5, 0, 0, 2},
+                {"large", LOGSIGN, 1e5, 2147483647., 0, 0, 2},
+                {"huge", LOGSIGN, 2147483648., 1e300, 0, 0, 2},
+                {"subnorm", LOGSIGN, tiny, dmin, 0, 0, 1}}},
+        {"_Sin cos", false, k_cos, ref_cos, 0, 0, {
+                {"dense", DENSE, -pi, pi, 0, 0, 2},
+                {"random", UNIFORM, -1e5, 1e5, 0, 0, 2},
+                {"huge", LOGSIGN, 2147483648., 1e300, 0, 0, 2}}},
+        {"_Exp", false, k_exp, ref_exp, 0, 0, {
+                {"dense", DENSE, -1, 1, 0, 0, 2},
+                {"random", UNIFORM, -708, 709, 0, 0, 2},
+                {"subnorm", LOGMAG, tiny, dmin, 0, 0, 1},
+                {"tiny res", UNIFORM, -745, -708, 0, 0, 0}}},
+        /* pow is only as good as the logt it is linked with */
+        {"pow", false, k_pow, ref_pow, 0, 0, {
+                {"random", UNIFORM, 1e-3, 1e3, -50, 50, 0},
+                {"near 1", UNIFORM, .99, 1.01, -1e4, 1e4, 0},
+                {"subnorm", LOGMAG, tiny, dmin, .01, .5, 0}}},
+        {"atan2", false, k_atan2, ref_atan2, 0, 0, {
+                {"random", UNIFORM, -100, 100, -100, 100, 2},
+                {"ratio", LOGSIGN, 1e-30, 1e30, 1, 1, 2},
+                {"subnorm", LOGSIGN, tiny, dmin, -1, 1, 1}}},
+        {"_Sinf", true, k_sinf, ref_sin, v_sinf, s_sinf, {
+                {"dense", DENSE, -pi, pi, 0, 0, 2.5},
+                {"random", UNIFORM, -8192, 8192, 0, 0, 2.5},
+                {"subnorm", LOGSIGN, ftiny, fmin, 0, 0, 1}}},
+        {"_Cosf", true, k_cosf, ref_cos, v_cosf, s_cosf, {
+                {"dense", DENSE, -pi, pi, 0, 0, 2.5},
+                {"random", UNIFORM, -8192, 8192, 0, 0, 2.5}}},
+        {"_Expf", true, k_expf, ref_exp, v_expf, s_expf, {
+                {"dense", DENSE, -1, 1, 0, 0, 1.5},
+                {"random", UNIFORM, -87, 88.7, 0, 0, 1.5},
+                {"subnorm", LOGMAG, ftiny, fmin, 0, 0, 1},
+                {"tiny res", UNIFORM, -103, -87.4, 0, 0, 0}}},
+        {"_Atan2f", true, k_atan2f, ref_atan2, v_atan2f, s_atan2f, {
+                {"random", UNIFORM, -100, 100, -100, 100, 2.5},
+                {"ratio", LOGSIGN, 1e-18, 1e18, 1, 1, 2.5},
+                {"subnorm", LOGSIGN, ftiny, fmin, -1, 1, 2.5}}},
+    };
+}
+
+static const std::size_t NDENSE = 1 << 21, NRANDOM = 1 << 20;
+
+static std::vector<double> args(const argset & s, bool y, std::size_t n,
+    std::mt19937_64 & gen)
+{
+    double lo = y ? s.ylo : s.xlo, hi = y ? s.yhi : s.xhi;
+    std::vector<double> v(n);
+    std::uniform_real_distribution<double> u(0, 1);
+    for (std::size_t i = 0; i < n; ++i) {
+        double t = s.how == DENSE && !y ? (i + .5) / n : u(gen);
+        if ((s.how == LOGMAG || s.how == LOGSIGN) && lo > 0) {
+            v[i] = lo * std::exp(t * std::log(hi / lo));
+            if (s.how == LOGSIGN && !y && u(gen) < .5)
+                v[i] = -v[i];
+        } else
+            v[i] = lo + t * (hi - lo);
+    }
+    return v;
+}
+
+/* Error of v in ulps of the kernel's precision at ref */
+static double ulps(double v, real ref, bool single)
+{
+    int mant = single ? FLT_MANT_DIG : DBL_MANT_DIG;
+    int emin = single ? FLT_MIN_EXP : DBL_MIN_EXP;
+    if (std::isnan(v) || std::isnan((double) ref))
+        return std::isnan(v) == std::isnan((double) ref) ? 0 : HUGE_VAL;
+    if (ref == 0)
+        return v == 0 ? 0 : HUGE_VAL;
+    int e;
+    frexpl(ref, &e);
+    if (e < emin)
+        e = emin;               /* subnormal results */
+    return (double) (fabsl(v - ref) / ldexpl(1, e - mant));
+}
+
+/* ns per element of f over the arrays, best of several runs */
+template < class F > static double timeit(F f, std::size_t n,
+    double *cycles)
+{
+    double best = HUGE_VAL, bestc = 0;
+    for (int run = 0; run < 7; ++run) {
+        auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+        unsigned long long c0 = __rdtsc();
+#endif
+        const int reps = 20;
+        for (int k = 0; k < reps; ++k)
+            f();
+#ifdef HAVE_RDTSC
+        double c = (double) (__rdtsc() - c0) / ((double) reps * n);
+#else
+        double c = 0;
+#endif
+        double t = std::chrono::duration < double, std::nano >
+            (std::chrono::steady_clock::now() - t0).count() /
+            ((double) reps * n);
+        if (t < best)
+            best = t, bestc = c;
+    }
+    *cycles = bestc;
+    return best;
+}
+
+static volatile double sink;
+
+int main()
+{
+    std::mt19937_64 gen(19921201);
+    int failed = 0;
+
+    printf("%-9s %-9s %9s %10s %10s  %-24s %7s %7s %6s\n", "kernel",
+        "set", "n", "max ulp", "mean ulp", "worst at", "ns", "cycles",
+        "vec x");
+    for (const kernel & k : kernels()) {
+        for (const argset & s : k.sets) {
+            std::size_t n = s.how == DENSE ? NDENSE : NRANDOM;
+            std::vector<double> x = args(s, false, n, gen);
+            std::vector<double> y = args(s, true, n, gen);
+            if (k.single)
+                for (std::size_t i = 0; i < n; ++i)
+                    x[i] = (float) x[i], y[i] = (float) y[i];
+
+            double worst = 0, sum = 0, wx = 0, wy = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                double e = ulps(k.f(x[i], y[i]), k.ref(x[i], y[i]),
+                    k.single);
+                sum += e;
+                if (e > worst)
+                    worst = e, wx = x[i], wy = y[i];
+            }
+
+            /* Time a cache-resident slice */
+            const std::size_t m = 4096;
+            double cyc, ns, vx = 0;
+            if (k.vec) {
+                std::vector<float> fx(x.begin(), x.begin() + m);
+                std::vector<float> fy(y.begin(), y.begin() + m), r(m);
+                double vc;
+                ns = timeit([&] {
+                    k.scalar(r.data(), fx.data(), fy.data(), m);
+                    sink = r[m - 1];}, m, &cyc);
+                double vns = timeit([&] {
+                    k.vec(r.data(), fx.data(), fy.data(), m);
+                    sink = r[m - 1];}, m, &vc);
+                vx = ns / vns;
+            } else
+                ns = timeit([&] {
+                    double acc = 0;
+                    for (std::size_t i = 0; i < m; ++i)
+                        acc += k.f(x[i], y[i]);
+                    sink = acc;}, m, &cyc);
+
+            bool bad = s.limit > 0 && !(worst <= s.limit);
+            failed |= bad;
+            char at[32];
+            if (s.ylo != 0 || s.yhi != 0)
+                snprintf(at, sizeof at, "%.6g,%.6g", wx, wy);
+            else
+                snprintf(at, sizeof at, "%.9g", wx);
+            printf("%-9s %-9s %9zu %10.3g %10.3g  %-24s %7.2f %7.1f ",
+                k.name, s.name, n, worst, sum / n, at, ns, cyc);
+            if (vx > 0)
+                printf("%6.1f", vx);
+            else
+                printf("%6s", "-");
+            printf("%s\n", bad ? "  FAIL" : "");
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,122 @@
+/* poly.h - polynomial evaluation templated on the coefficients
+**
+** _Horner<C>(x), _Estrin<C>(x) and _Evenodd<C>(x) all compute
+**    C[0] + C[1]*x + C[2]*x^2 + ... + C[N-1]*x^(N-1)
+** for a constexpr array C, fully unrolled at compile time.  They
+** differ only in the shape of the dependency chain:
+**
+**    Horner   N-1 multiply-adds, one after the other; the fewest
+**             operations, so best when the loop is throughput bound
+**             (vectorized over an array).
+**    Estrin   pairs c[i] + c[i+1]*x, then pairs of pairs with x^2,
+**             x^4, ...; depth about 2*log2(N) but log2(N) extra
+**             multiplies for the powers.
+**    Evenodd  the even and odd coefficients as two Horner chains in
+**             x*x, joined by one multiply-add; half the depth for
+**             one extra multiply.
+**
+** _Poly<C>(x) picks per target from what polytime.cpp measured
+** with gcc 12 on an AVX-512 Xeon.  In a dependency chain Estrin was
+** fastest everywhere from four terms (11 terms: 16 ns against 44
+** for Horner, 10.5 against 19 with FMA), and even/odd came second.
+** With FMA a three-term Horner is two fused operations and ties or
+** beats Estrin, so it is kept below POLY_SHORT terms.  Over
+** arrays the three schemes were within noise of each other.  Define
+** POLY_SCHEME to force one scheme for every series.
+**
+** The schemes round differently: the fkernel.h errors moved by a few
+** hundredths of an ulp between them, the listing3.c series (which
+** already splits its chain with g4) by a tenth for no measurable
+** gain in _Sin, so the C listings keep their hand-written forms.
+*/
+#ifndef POLY_H
+#define POLY_H
+
+#include <cstddef>
+#include <iterator>
+
+#define POLY_HORNER 0
+#define POLY_ESTRIN 1
+#define POLY_EVENODD 2
+
+#ifndef POLY_SHORT
+#ifdef __FMA__
+#define POLY_SHORT 4
+#else
+#define POLY_SHORT 3
+#endif
+#endif
+
+/* C[I] + x*C[I+S] + x^2*C[I+2S] + ... */
+template < const auto & C, std::size_t I = 0, std::size_t S = 1, class T >
+constexpr T _Horner(T x)
+{
+    if constexpr (I + S >= std::size(C))
+        return T(C[I]);
+    else
+        return T(C[I]) + x * _Horner < C, I + S, S > (x);
+}
+
+constexpr std::size_t _Floorlog2(std::size_t n)
+{
+    return n < 2 ? 0 : 1 + _Floorlog2(n / 2);
+}
+
+/* x^(2^K); the compiler shares the squarings between the calls.
+** A table of powers filled by a loop cost _Atan2f its inlining, and
+** with it the vectorized _Vatan2f. */
+template < std::size_t K, class T > constexpr T _Square(T x)
+{
+    if constexpr (K == 0)
+        return x;
+    else {
+        T y = _Square < K - 1 > (x);
+        return y * y;
+    }
+}
+
+/* C[I] + ... + C[I+L-1]*x^(L-1) */
+template < const auto & C, std::size_t I, std::size_t L, class T >
+constexpr T _Estrin_part(T x)
+{
+    if constexpr (L == 1)
+        return T(C[I]);
+    else {
+        constexpr std::size_t k = _Floorlog2(L - 1), h = std::size_t(1) << k;
+        return _Estrin_part < C, I, h > (x) +
+            _Square < k > (x) * _Estrin_part < C, I + h, L - h > (x);
+    }
+}
+
+template < const auto & C, class T > constexpr T _Estrin(T x)
+{
+    return _Estrin_part < C, 0, std::size(C) > (x);
+}
+
+template < const auto & C, class T > constexpr T _Evenodd(T x)
+{
+    if constexpr (std::size(C) < 2)
+        return T(C[0]);
+    else {
+        T x2 = x * x;
+        return _Horner < C, 0, 2 > (x2) + x * _Horner < C, 1, 2 > (x2);
+    }
+}
+
+template < const auto & C, class T > constexpr T _Poly(T x)
+{
+#if !defined(POLY_SCHEME)
+    if constexpr (std::size(C) < POLY_SHORT)
+        return _Horner < C > (x);
+    else
+        return _Estrin < C > (x);
+#elif POLY_SCHEME == POLY_ESTRIN
+    return _Estrin < C > (x);
+#elif POLY_SCHEME == POLY_EVENODD
+    return _Evenodd < C > (x);
+#else
+    return _Horner < C > (x);
+#endif
+}
+
+#endif /* POLY_H */
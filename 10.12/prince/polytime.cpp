@@ -0,0 +1,145 @@
+/* polytime.cpp - time the poly.h schemes on the kernel series
+**
+** For each coefficient table, ns per evaluation of Horner, Estrin
+** and even/odd:
+**    chain    each argument depends on the last result, so the time
+**             is the latency of the dependency chain
+**    scalar   independent arguments, loop kept scalar
+**    vector   independent arguments, loop vectorized
+** The scheme fastest in the chain column is the one _Poly should
+** use on the target, as the kernels are called one at a time far
+** more often than over arrays; the vector column says what the
+** array forms in fkernel.h give up for it.
+**
+** Build like mathtest:
+**    c++ -O2 -fopenmp-simd -fno-trapping-math -mavx2 -mfma polytime.cpp
+*/
+#include "fkernel.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define SCALAR __attribute__((optimize("no-tree-vectorize")))
+#else
+#define SCALAR
+#endif
+
+/* The double series of listing3.c and listing6.c */
+constexpr double _Sin_coef[] = {
+    -.16666666666666616, .00833333333332036, -.00019841269828653,
+    .0000027557313377252, -.000000025050717097, .00000000015894743,
+};
+constexpr double _Cos_coef[] = {
+    -.499999999999999994, .041666666666666452, -.001388888888886110,
+    .000024801587283884, -.000000275573130985, .000000002087558246,
+    -.000000000011353383,
+};
+constexpr double _Atan_coef[] = {
+    .33333333333332713, -.19999999999844163, .14285714270355533,
+    -.11111110327242694, .09090885408512523, -.0769185192745614,
+    .06660850184641357, -.05832239923826337, .04971908607172078,
+    -.03642599200325829, .01618847031840557,
+};
+
+static const std::size_t M = 4096;
+static volatile double sink;
+
+template < class F > static double best(F f)
+{
+    double t = HUGE_VAL;
+    for (int run = 0; run < 7; ++run) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int k = 0; k < 50; ++k)
+            f();
+        double d = std::chrono::duration < double, std::nano >
+            (std::chrono::steady_clock::now() - t0).count() / (50. * M);
+        t = d < t ? d : t;
+    }
+    return t;
+}
+
+template < class T, T(*P) (T) > struct scheme {
+    /* The argument stays in range: the result feeds in scaled down */
+    static double chain(const std::vector < T > &x)
+    {
+        return best([&] {
+            T r = 0;
+            for (std::size_t i = 0; i < M; ++i)
+                r = P(x[i] + r * T(1e-6));
+            sink = r;});
+    }
+    SCALAR static void sloop(T * r, const T * x)
+    {
+        for (std::size_t i = 0; i < M; ++i)
+            r[i] = P(x[i]);
+    }
+    static void vloop(T * r, const T * x)
+    {
+#pragma omp simd
+        for (std::size_t i = 0; i < M; ++i)
+            r[i] = P(x[i]);
+    }
+    static double scalar(const std::vector < T > &x, std::vector < T > &r)
+    {
+        return best([&] {
+            sloop(r.data(), x.data());
+            sink = r[M - 1];});
+    }
+    static double vector(const std::vector < T > &x, std::vector < T > &r)
+    {
+        return best([&] {
+            vloop(r.data(), x.data());
+            sink = r[M - 1];});
+    }
+};
+
+template < const auto & C > static void row(const char *name, double hi)
+{
+    typedef typename std::remove_cv < typename std::remove_reference <
+        decltype(C[0]) >::type >::type T;
+    typedef scheme < T, _Horner < C, 0, 1, T > > H;
+    typedef scheme < T, _Estrin < C, T > > E;
+    typedef scheme < T, _Evenodd < C, T > > O;
+    std::mt19937 gen(19921201);
+    std::uniform_real_distribution < double > u(0, hi);
+    std::vector < T > x(M), r(M);
+    for (T & v : x)
+        v = T(u(gen));
+
+    double t[3][3] = {
+        {H::chain(x), H::scalar(x, r), H::vector(x, r)},
+        {E::chain(x), E::scalar(x, r), E::vector(x, r)},
+        {O::chain(x), O::scalar(x, r), O::vector(x, r)},
+    };
+    int pick = 0;
+    for (int s = 1; s < 3; ++s)
+        if (t[s][0] < t[pick][0])
+            pick = s;
+    static const char *names[] = {"horner", "estrin", "evenodd"};
+    printf("%-8s %2zu", name, std::size(C));
+    for (int k = 0; k < 3; ++k)
+        printf("   %6.2f %6.2f %6.2f", t[0][k], t[1][k], t[2][k]);
+    printf("   %s\n", names[pick]);
+}
+
+int main()
+{
+    printf("%-8s %2s   %-20s   %-20s   %-20s   %s\n", "series", "n",
+        "chain", "scalar", "vector", "best");
+    printf("%11s", "");
+    for (int k = 0; k < 3; ++k)
+        printf("   %6s %6s %6s", "H", "E", "O");
+    printf("   (POLY_SHORT %d)\n", POLY_SHORT);
+    row < _Sinf_coef > ("sinf", .62);
+    row < _Cosf_coef > ("cosf", .62);
+    row < _Expf_coef > ("expf", .35);
+    row < _Atanf_coef > ("atanf", .19);
+    row < _Sin_coef > ("sin", .62);
+    row < _Cos_coef > ("cos", .62);
+    row < _Atan_coef > ("atan", .19);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#define K 8                     /* words of 2/pi used per product */
+
+/* Payne-Hanek reduction of x by pi/2, for the arguments too big
+ * for the split constants in _Sin.  The 53-bit mantissa is
+ * multiplied by a window of 2/pi chosen so that the bits dropped
+ * above it only add multiples of 4 to the quadrant, and the bits
+ * dropped below it are 2^-160 and smaller; the fraction left is
+ * then multiplied by pi/4 in 128-bit fixed point.  The result is
+ * good to the last bit for every finite double, including the
+ * ones lying closest to a multiple of pi/2. */
+
+/* 2/pi, 1280 fraction bits, most significant word first */
+static const uint32_t twobypi[40] = {
+    0xA2F9836E, 0x4E441529, 0xFC2757D1, 0xF534DDC0,
+    0xDB629599, 0x3C439041, 0xFE5163AB, 0xDEBBC561,
+    0xB7246E3A, 0x424DD2E0, 0x06492EEA, 0x09D1921C,
+    0xFE1DEB1C, 0xB129A73E, 0xE88235F5, 0x2EBB4484,
+    0xE99C7026, 0xB45F7E41, 0x3991D639, 0x835339F4,
+    0x9C845F8B, 0xBDF9283B, 0x1FF897FF, 0xDE05980F,
+    0xEF2F118B, 0x5A0A6D1F, 0x6D367ECF, 0x27CB09B7,
+    0x4F463F66, 0x9E5FEA2D, 0x7527BAC7, 0xEBE5F17B,
+    0x3D0739F7, 0x8A5292EA, 0x6BFB5FB1, 0x1F8D5D08,
+    0x56033046, 0xFC7B6BAB, 0xF0CFBC20, 0x9AF4361D,
+};
+
+/* pi/4, 128 fraction bits, least significant word first */
+static const uint32_t pio4[4] = {
+    0x80DC1CD1, 0xC4C6628B, 0x2168C234, 0xC90FDAA2,
+};
+
+/* r[0..m+n-1] = a[0..m-1] * b[0..n-1], 32-bit words least
+ * significant first */
+static void mul(r, a, m, b, n)
+uint32_t *r;
+const uint32_t *a, *b;
+int m, n;
+{
+    int i, j;
+
+    for (i = 0; i < m + n; ++i)
+        r[i] = 0;
+    for (j = 0; j < n; ++j) {
+        uint64_t c = 0;
+
+        for (i = 0; i < m; ++i) {
+            c += (uint64_t) a[i] * b[j] + r[i + j];
+            r[i + j] = (uint32_t) c;
+            c >>= 32;
+        }
+        r[m + j] = (uint32_t) c;
+    }
+}
+
+/* the 64 bits of s[0..n-1] starting at bit pos */
+static uint64_t bits64(s, n, pos)
+const uint32_t *s;
+int n, pos;
+{
+    int k = pos / 32, sh = pos % 32;
+    uint64_t lo = s[k] | (uint64_t) (k + 1 < n ? s[k + 1] : 0) << 32;
+    uint64_t hi = k + 2 < n ? s[k + 2] : 0;
+
+    return sh ? lo >> sh | hi << (64 - sh) : lo;
+}
+
+int _Sinred(x, pr)
+double x;
+double *pr;
+{                               /* x = quad*pi/2 + *pr, |*pr| <= pi/4 */
+    uint32_t w[K], mw[2], s[K + 2], f[4], r[8];
+    uint64_t m, hi, lo, fh, fl;
+    double g;
+    int e, j0, p, i;
+    unsigned int quad;
+    int neg = 0;
+
+    if (!(fabs(x) <= DBL_MAX)) {        /* Inf or NaN */
+        *pr = x - x;
+        return 0;
+    }
+    g = frexp(fabs(x), &e);
+    m = (uint64_t) ldexp(g, 53);
+    e -= 53;                    /* x = m * 2^e */
+
+    /* Words of 2/pi before j0 give m * 2/pi bits of weight 4 and
+     * up, so only a window of K words need be multiplied */
+    j0 = e > 2 ? (e - 2) / 32 : 0;
+    for (i = 0; i < K; ++i)
+        w[i] = twobypi[j0 + K - 1 - i];
+    mw[0] = (uint32_t) m;
+    mw[1] = (uint32_t) (m >> 32);
+    mul(s, w, K, mw, 2);
+
+    /* Binary point at bit p: two integer bits then 126 of fraction */
+    p = 32 * (j0 + K) - e;
+    hi = bits64(s, K + 2, p - 62);
+    lo = bits64(s, K + 2, p - 126);
+    quad = (unsigned int) (hi >> 62);
+    fh = hi << 2 | lo >> 62;
+    fl = lo << 2;
+    if (fh >> 63) {             /* past the half, round up */
+        ++quad;
+        neg = 1;
+        fl = ~fl + 1;           /* 1 - fraction */
+        fh = ~fh + (fl == 0);
+    }
+
+    /* r = 2 * fraction * pi/4 */
+    f[0] = (uint32_t) (fl << 1);
+    f[1] = (uint32_t) (fl >> 31);
+    f[2] = (uint32_t) (fh << 1 | fl >> 63);
+    f[3] = (uint32_t) (fh >> 31);
+    mul(r, f, 4, pio4, 4);
+    hi = (uint64_t) r[7] << 32 | r[6];
+    lo = (uint64_t) r[5] << 32 | r[4];
+    for (e = -64; hi >> 63 == 0 && e > -256; --e) {
+        hi = hi << 1 | lo >> 63;
+        lo <<= 1;
+    }
+    g = ldexp((double) hi, e);
+    if (neg)
+        g = -g;
+    if (x < 0) {
+        g = -g;
+        quad = -quad;
+    }
+    *pr = g;
+    return quad & 3;
+}
@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "optree.h"
+
+/* Parallel tree optimization for very large trees.
+
+   The top of the tree is cut into pieces: whole subtrees,
+   and the single nodes above them. Worker threads flatten
+   the subtrees into separate vines at the same time, each
+   with optree_vine. The vine lengths give every piece its
+   offset, so the pieces are stitched into one in-order
+   array of node pointers, again in parallel. The balanced
+   tree is then formed from the array as form_tree in
+   listing1.c forms it from the list (same middle, same
+   five-node case, same lean to the center), except that
+   the left half can be handed to another thread while the
+   current one forms the right half.
+
+   The cut follows the shape of the top of the tree, so a
+   tree degenerated into a list flattens on one thread; the
+   forming still runs in parallel.
+
+   Only that path gives form_tree's shape. With fewer than
+   two threads the tree goes to optree_r, and without room
+   for the array the vines are joined and folded in place
+   as optree_r folds them; both give optree_r's shape, of
+   the same height. */
+
+/* THE ARRAY OF NODE POINTERS IS TAKEN WITH OPTPAR_ALLOC,
+   SO THAT A TEST CAN MAKE IT FAIL */
+#ifndef OPTPAR_ALLOC
+#define OPTPAR_ALLOC(size) malloc(size)
+#endif
+
+#define MAXPIECES 4096
+#define PERTHREAD 8             /* SUBTREES WANTED PER THREAD */
+#define GRAIN     65536L        /* SMALLEST HALF WORTH A THREAD */
+
+typedef struct piece {
+  TREENODE *node;
+  int       whole;      /* THE SUBTREE AT node, OR node ALONE */
+  TREENODE  base;       /* HEAD OF ITS VINE */
+  long      num;        /* NODES IN THE VINE */
+  long      at;         /* WHERE THEY GO IN THE ARRAY */
+} PIECE;
+
+typedef struct par {
+  PIECE          *piece;
+  int             npiece;
+  int             next;         /* NEXT PIECE TO TAKE */
+  int             phase;        /* 0 FLATTEN, 1 STITCH */
+  pthread_mutex_t lock;
+  TREENODE      **list;
+} PAR;
+
+typedef struct form {
+  TREENODE **list;
+  long       num;
+  int        left;
+  int        forks;     /* THREADS THIS CALL MAY START */
+  TREENODE  *ptr;
+} FORM;
+
+static int       cut      (PIECE *, PIECE *, TREENODE *, int);
+static void     *work     (void *);
+static void      run      (PAR *, int);
+static TREENODE *form_par (TREENODE **, long, int, int);
+static void     *form_job (void *);
+
+/* OPTIMIZE A TREE WITH UP TO nthreads THREADS */
+void *optree_par(OPTREE_CTX *ctx, void *opt_root, int nthreads)
+{
+  PAR par;
+  PIECE *tmp;
+  long num;
+  int i;
+
+  ctx->count = 0;
+  if (opt_root == NULL) return(NULL);
+  if (nthreads < 2) return(optree_r(ctx, opt_root));
+
+  par.piece = (PIECE *) malloc(2 * MAXPIECES * sizeof(PIECE));
+  if (par.piece == NULL) return(optree_r(ctx, opt_root));
+  tmp = par.piece + MAXPIECES;
+  par.npiece = cut(par.piece, tmp, (TREENODE *) opt_root,
+                   nthreads * PERTHREAD);
+  pthread_mutex_init(&par.lock, NULL);
+
+  /* FLATTEN THE SUBTREES */
+  par.phase = 0;
+  run(&par, nthreads);
+
+  /* STITCH: EACH PIECE STARTS WHERE THE LAST ENDED */
+  for (num = 0, i = 0; i < par.npiece; i++) {
+    par.piece[i].at = num;
+    num += par.piece[i].num;
+  }
+  par.list = (TREENODE **)
+             OPTPAR_ALLOC((size_t) num * sizeof(TREENODE *));
+  if (par.list == NULL) {
+    /* NO ROOM: JOIN THE VINES AND FOLD THEM IN PLACE. A
+       LONE NODE STILL HAS ITS OLD LINKS INTO OTHER PIECES,
+       WHICH THE FOLD WOULD FOLLOW, SO THEY ARE CLEARED */
+    TREENODE *tail = &ctx->base;
+    for (i = 0; i < par.npiece; i++) {
+      if (!par.piece[i].whole)
+        par.piece[i].node->left = par.piece[i].node->right = NULL;
+      tail->right = par.piece[i].base.right;
+      for (num = par.piece[i].num; num-- > 0; )
+        tail = tail->right;
+    }
+    tail->right = NULL;
+    for (num = 0, i = 0; i < par.npiece; i++)
+      num += par.piece[i].num;
+    ctx->base.left = NULL;
+    optree_fold(&ctx->base, ctx->count = num);
+  }
+  else {
+    par.phase = 1;
+    run(&par, nthreads);
+    ctx->base.left = NULL;
+    ctx->base.right = form_par(par.list, num, 0, nthreads - 1);
+    ctx->count = num;
+    free(par.list);
+  }
+  pthread_mutex_destroy(&par.lock);
+  free(par.piece);
+  return((void *) ctx->base.right);
+}
+
+/* CUT THE TOP OF THE TREE INTO PIECES, IN ORDER, UNTIL
+   THERE ARE want SUBTREES OR NO ROOM FOR ANOTHER ROUND */
+static int cut(PIECE *piece, PIECE *tmp, TREENODE *root, int want)
+{
+  int n = 1, m, i, whole;
+  TREENODE *node;
+
+  piece[0].node = root;
+  piece[0].whole = 1;
+  for (;;) {
+    for (whole = 0, m = 0, i = 0; i < n; i++)
+      if (piece[i].whole) {
+        whole++;
+        m += 1 + (piece[i].node->left != NULL) +
+                 (piece[i].node->right != NULL);
+      }
+      else m++;
+    if (whole == 0 || whole >= want || m > MAXPIECES) return(n);
+
+    /* EACH SUBTREE BECOMES LEFT SUBTREE, NODE, RIGHT SUBTREE */
+    for (m = 0, i = 0; i < n; i++) {
+      node = piece[i].node;
+      if (piece[i].whole && node->left != NULL) {
+        tmp[m].node = node->left;
+        tmp[m++].whole = 1;
+      }
+      tmp[m].node = node;
+      tmp[m++].whole = 0;
+      if (piece[i].whole && node->right != NULL) {
+        tmp[m].node = node->right;
+        tmp[m++].whole = 1;
+      }
+    }
+    for (n = m, i = 0; i < n; i++)
+      piece[i] = tmp[i];
+  }
+}
+
+/* WORKER: TAKE PIECES UNTIL NONE ARE LEFT */
+static void *work(void *arg)
+{
+  PAR *par = (PAR *) arg;
+  PIECE *p;
+  TREENODE *node, **out;
+  long k;
+  int i;
+
+  for (;;) {
+    pthread_mutex_lock(&par->lock);
+    i = par->next++;
+    pthread_mutex_unlock(&par->lock);
+    if (i >= par->npiece) return(NULL);
+    p = &par->piece[i];
+
+    if (par->phase == 0) {
+      /* A LONE NODE IS A VINE OF ONE; ITS LINKS STILL POINT
+         INTO PIECES OTHER THREADS OWN, AND ARE NOT FOLLOWED */
+      p->base.right = p->node;
+      p->num = p->whole ? optree_vine(&p->base) : 1;
+    }
+    else {
+      out = par->list + p->at;
+      node = p->base.right;
+      for (k = 0; k < p->num; k++) {
+        out[k] = node;
+        node = node->right;
+      }
+    }
+  }
+}
+
+/* RUN ONE PHASE ON nthreads THREADS, THIS ONE INCLUDED */
+static void run(PAR *par, int nthreads)
+{
+  pthread_t *tid;
+  int i, started = 0;
+
+  par->next = 0;
+  tid = (pthread_t *) malloc((size_t) nthreads * sizeof(pthread_t));
+  if (tid != NULL)
+    for (i = 1; i < nthreads; i++)
+      if (pthread_create(&tid[started], NULL, work, par) == 0)
+        started++;
+  work(par);
+  for (i = 0; i < started; i++)
+    pthread_join(tid[i], NULL);
+  free(tid);
+}
+
+/* FORM AN OPTIMIZED TREE FROM list[0..num-1], AS form_tree
+   DOES; left TELLS WHICH WAY THE SUBTREE LEANS */
+static TREENODE *form_par(TREENODE **list, long num, int left, int forks)
+{
+  long middle;
+  TREENODE *ptr;
+  pthread_t tid;
+  FORM job;
+
+  if (num <= 0) return(NULL);
+
+  middle = (num >> 1);   /* (num / 2) */
+
+  /* SPECIAL 5-NODE CASE */
+  if(num == 5) middle++;
+
+  /* LEAN BRANCH TO CENTER OF TREE */
+  if(left) middle = num - middle - 1;
+
+  ptr = list[middle];
+  job.list  = list;
+  job.num   = middle;
+  job.left  = 1;
+  job.forks = (forks - 1) / 2;
+  if (forks > 0 && middle >= GRAIN &&
+      pthread_create(&tid, NULL, form_job, &job) == 0) {
+    /* LEFT HALF ON ANOTHER THREAD, RIGHT HALF ON THIS ONE */
+    ptr->right = form_par(list + middle + 1, num - middle - 1, 0,
+                          forks - 1 - job.forks);
+    pthread_join(tid, NULL);
+    ptr->left = job.ptr;
+  }
+  else {
+    ptr->left  = form_par(list, middle, 1, 0);
+    ptr->right = form_par(list + middle + 1, num - middle - 1, 0, 0);
+  }
+  return ptr;
+}
+
+static void *form_job(void *arg)
+{
+  FORM *job = (FORM *) arg;
+
+  job->ptr = form_par(job->list, job->num, job->left, job->forks);
+  return(NULL);
+}
@@ -0,0 +1,121 @@
+/* Test of optree_par on both of its paths.
+
+   optpar.c is included here with OPTPAR_ALLOC made to fail
+   on request, so that the fallback (joining the vines and
+   folding them in place) runs as well as the array path.
+   Random, left-degenerate and right-degenerate trees are
+   rebuilt with 2, 4 and 8 threads; every node must still
+   be reachable, in order, and the tree must be of least
+   height.
+
+     cc -O2 -pthread optptest.c optree.c -o optptest
+     ./optptest                                           */
+
+#include <stdio.h>
+
+static int fail_alloc;          /* MAKE OPTPAR_ALLOC FAIL */
+
+#define OPTPAR_ALLOC(size) (fail_alloc ? NULL : malloc(size))
+#include "optpar.c"
+
+#define NUM 200000L
+
+typedef struct node {
+  TREENODE link;                /* FIRST, SO A TREENODE * CASTS */
+  long     key;
+} NODE;
+
+static NODE  nodes[NUM];
+static unsigned long lcg = 1;
+
+/* BUILD A TREE OF THE num NODES: shape 0 RANDOM (KEYS
+   INSERTED IN RANDOM ORDER), 1 ALL LEFT, 2 ALL RIGHT */
+static TREENODE *make_tree(long num, int shape)
+{
+  static long order[NUM];
+  TREENODE *root = NULL, **at;
+  long i, j, t;
+
+  for (i = 0; i < num; i++) {
+    nodes[i].key = i;
+    nodes[i].link.left = nodes[i].link.right = NULL;
+  }
+  if (shape == 1) {
+    for (i = 1; i < num; i++)
+      nodes[i].link.left = &nodes[i - 1].link;
+    return(&nodes[num - 1].link);
+  }
+  if (shape == 2) {
+    for (i = 0; i + 1 < num; i++)
+      nodes[i].link.right = &nodes[i + 1].link;
+    return(&nodes[0].link);
+  }
+  for (i = 0; i < num; i++) order[i] = i;
+  for (i = num - 1; i > 0; i--) {
+    lcg = lcg * 1103515245UL + 12345UL;
+    j = (long) ((lcg >> 8) % (unsigned long) (i + 1));
+    t = order[i], order[i] = order[j], order[j] = t;
+  }
+  for (i = 0; i < num; i++) {
+    for (at = &root; *at != NULL; )
+      at = ((NODE *) *at)->key > order[i] ? &(*at)->left
+                                           : &(*at)->right;
+    *at = &nodes[order[i]].link;
+  }
+  return(root);
+}
+
+/* WALK THE TREE IN ORDER; RETURN THE NODES SEEN IN KEY
+   ORDER BEFORE THE FIRST MISTAKE, AND ITS HEIGHT */
+static long check_tree(TREENODE *root, int *height)
+{
+  static TREENODE *stack[NUM];
+  static int depth[NUM];
+  TREENODE *node = root;
+  long seen = 0;
+  int sp = 0, d = 1;
+
+  *height = 0;
+  while (node != NULL || sp > 0) {
+    while (node != NULL) {
+      if (sp == NUM) return(seen);      /* A CYCLE */
+      if (d > *height) *height = d;
+      depth[sp] = d++;
+      stack[sp++] = node;
+      node = node->left;
+    }
+    node = stack[--sp];
+    d = depth[sp] + 1;
+    if (((NODE *) node)->key != seen) return(seen);
+    seen++;
+    node = node->right;
+  }
+  return(seen);
+}
+
+int main(void)
+{
+  static const char *shape_name[] = { "random", "left", "right" };
+  OPTREE_CTX ctx;
+  TREENODE *root;
+  long seen;
+  int shape, threads, height, least, failures = 0;
+
+  for (least = 0; (1L << least) - 1 < NUM; least++)
+    ;
+  for (fail_alloc = 0; fail_alloc <= 1; fail_alloc++)
+    for (shape = 0; shape < 3; shape++)
+      for (threads = 2; threads <= 8; threads *= 2) {
+        root = (TREENODE *) optree_par(&ctx, make_tree(NUM, shape),
+                                       threads);
+        seen = check_tree(root, &height);
+        printf("%-8s %-6s %d threads: %ld of %ld in order, "
+               "height %d of %d\n",
+               fail_alloc ? "fallback" : "array", shape_name[shape],
+               threads, seen, NUM, height, least);
+        if (seen != NUM || ctx.count != NUM || height != least)
+          failures++;
+      }
+  printf(failures ? "%d FAILED\n" : "all passed\n", failures);
+  return(failures != 0);
+}
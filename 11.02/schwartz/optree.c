@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <string.h>
+#include "optree.h"
+
+/* Iterative tree optimization after Day, Stout and Warren.
+   The tree is flattened into a right-leaning "vine" by
+   rotations rather than by a recursive traversal, then
+   folded into a balanced tree by repeated left rotations
+   down the vine. Neither step recurses or allocates, so a
+   badly degenerated tree of any size is safe, and the only
+   state is the caller's OPTREE_CTX.
+
+   The result has the same height as the tree form_tree
+   builds, but its bottom level is filled from the left
+   rather than leaning toward the center of each parent. */
+
+static void compress  (TREENODE *, long);
+static long pack_walk (TREENODE *, char *, size_t, long);
+static long bfs_first (long);
+static long bfs_next  (long, long);
+
+/* OPTIMIZE A TREE */
+void *optree_r(OPTREE_CTX *ctx, void *opt_root)
+{
+  ctx->count = 0;
+  if (opt_root == NULL) return(NULL);
+
+  ctx->base.left  = NULL;
+  ctx->base.right = (TREENODE *) opt_root;
+  ctx->count = optree_vine(&ctx->base);
+  optree_fold(&ctx->base, ctx->count);
+
+  return((void *) ctx->base.right);
+}
+
+/* FLATTEN TREE INTO VINE HANGING FROM base->right, AND
+   COUNT ITS NODES */
+long optree_vine(TREENODE *base)
+{
+  TREENODE *tail = base;
+  TREENODE *rest = base->right;
+  TREENODE *temp;
+  long num = 0;
+
+  while (rest != NULL) {
+    if (rest->left == NULL) {
+      /* NOTHING TO THE LEFT: MOVE DOWN THE VINE */
+      tail = rest;
+      rest = rest->right;
+      num++;
+    }
+    else {
+      /* ROTATE RIGHT, LIFTING THE LEFT CHILD ONTO THE VINE */
+      temp = rest->left;
+      rest->left = temp->right;
+      temp->right = rest;
+      rest = temp;
+      tail->right = temp;
+    }
+  }
+  return(num);
+}
+
+/* FOLD THE size-NODE VINE HANGING FROM base->right INTO A
+   BALANCED TREE, LEFT IN base->right */
+void optree_fold(TREENODE *base, long size)
+{
+  long full;
+
+  /* FULL IS THE LARGEST 2^k - 1 NOT OVER size; THE NODES
+     PAST IT GO TO THE BOTTOM LEVEL IN THE FIRST PASS */
+  for (full = 1; full <= size; full = full + full + 1)
+    ;
+  full >>= 1;
+  compress(base, size - full);
+
+  /* EACH PASS HALVES THE VINE, ADDING A LEVEL BELOW IT */
+  for (size = full; size > 1; size >>= 1)
+    compress(base, size >> 1);
+}
+
+/* ROTATE LEFT count TIMES DOWN THE VINE, EVERY SECOND NODE
+   BECOMING THE LEFT CHILD OF THE NODE AFTER IT */
+static void compress(TREENODE *base, long count)
+{
+  TREENODE *scan = base;
+  TREENODE *child;
+
+  while (count-- > 0) {
+    child = scan->right;
+    scan->right = child->right;
+    scan = scan->right;
+    child->right = scan->left;
+    scan->left = child;
+  }
+}
+
+/* COPY A TREE INTO ONE ARRAY IN BREADTH-FIRST (EYTZINGER)
+   ORDER: THE ROOT AT ELEMENT 0, THE CHILDREN OF ELEMENT k
+   AT 2k+1 AND 2k+2. THE TOP LEVELS OF EVERY SEARCH SHARE
+   THE FIRST FEW CACHE LINES, AND EACH LEVEL'S CHILDREN ARE
+   ADJACENT, SO A LOOKUP NO LONGER TAKES A MISS PER LEVEL
+   ON NODES SCATTERED BY malloc.
+
+   THE ARRAY HOLDS THE SAME SHAPE optree_r BUILDS, WHATEVER
+   THE SHAPE OF THE TREE PASSED. size IS THE SIZE OF A WHOLE
+   NODE, DATA INCLUDED; EACH IS COPIED WITH memcpy AND ITS
+   LINKS SET AS mode SAYS. THE OLD NODES ARE LEFT AS THEY
+   WERE, FOR THE CALLER TO FREE OR KEEP. RETURNS THE ARRAY
+   (TO BE RELEASED WITH free), OR NULL IF THE TREE IS EMPTY
+   OR THE ALLOCATION FAILS. */
+void *optree_pack(OPTREE_CTX *ctx, void *opt_root, size_t size, int mode)
+{
+  char *buf;
+  TREENODE *node;
+  long n, k;
+
+  ctx->count = 0;
+  if (opt_root == NULL) return(NULL);
+
+  n = pack_walk((TREENODE *) opt_root, NULL, size, 0);
+  if ((buf = (char *) malloc((size_t) n * size)) == NULL)
+    return(NULL);
+  pack_walk((TREENODE *) opt_root, buf, size, n);
+  ctx->count = n;
+
+  for (k = 0; k < n; k++) {
+    node = (TREENODE *) (buf + (size_t) k * size);
+    if (mode == OPTREE_INDEX)
+      node->left = node->right = NULL;
+    else {
+      node->left = OPTREE_LEFT(k) < n ?
+        (TREENODE *) (buf + (size_t) OPTREE_LEFT(k) * size) : NULL;
+      node->right = OPTREE_RIGHT(k) < n ?
+        (TREENODE *) (buf + (size_t) OPTREE_RIGHT(k) * size) : NULL;
+    }
+  }
+  return((void *) buf);
+}
+
+/* IN-ORDER (MORRIS) TRAVERSAL: EACH NODE'S PREDECESSOR IS
+   THREADED BACK TO IT ON THE WAY DOWN AND UNTHREADED ON THE
+   WAY UP, SO NO STACK IS NEEDED AND THE TREE IS RESTORED.
+   WITH buf NULL IT ONLY COUNTS; OTHERWISE THE r-TH NODE IS
+   COPIED TO THE ARRAY ELEMENT THAT IS r-TH IN ORDER. */
+static long pack_walk(TREENODE *cur, char *buf, size_t size, long n)
+{
+  TREENODE *pre;
+  long num = 0;
+  long k = buf ? bfs_first(n) : 0;
+
+  while (cur != NULL) {
+    if (cur->left != NULL) {
+      pre = cur->left;
+      while (pre->right != NULL && pre->right != cur)
+        pre = pre->right;
+      if (pre->right == NULL) {
+        /* THREAD AND GO LEFT */
+        pre->right = cur;
+        cur = cur->left;
+        continue;
+      }
+      pre->right = NULL;        /* LEFT SUBTREE DONE */
+    }
+    if (buf != NULL) {
+      memcpy(buf + (size_t) k * size, cur, size);
+      k = bfs_next(k, n);
+    }
+    num++;
+    cur = cur->right;
+  }
+  return(num);
+}
+
+/* FIRST ELEMENT IN ORDER OF AN n-ELEMENT EYTZINGER ARRAY */
+static long bfs_first(long n)
+{
+  long k = 0;
+
+  while (OPTREE_LEFT(k) < n)
+    k = OPTREE_LEFT(k);
+  return(k);
+}
+
+/* ELEMENT AFTER k IN ORDER, OR -1 AFTER THE LAST */
+static long bfs_next(long k, long n)
+{
+  if (OPTREE_RIGHT(k) < n) {
+    /* LEFTMOST OF THE RIGHT SUBTREE */
+    k = OPTREE_RIGHT(k);
+    while (OPTREE_LEFT(k) < n)
+      k = OPTREE_LEFT(k);
+    return(k);
+  }
+  /* UP PAST EVERY RIGHT CHILD, THEN ONE MORE */
+  while (k > 0 && (k & 1) == 0)
+    k = (k - 1) >> 1;
+  return(k > 0 ? (k - 1) >> 1 : -1);
+}
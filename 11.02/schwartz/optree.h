@@ -0,0 +1,54 @@
+#ifndef OPTREE_H
+#define OPTREE_H
+
+#include <stddef.h>
+
+/* TREE STRUCT: GENERIC BINARY TREE NODE, AS IN listing1.c */
+#ifndef TREENODE_DEFINED
+#define TREENODE_DEFINED
+typedef struct treenode {
+  struct treenode *left;
+  struct treenode *right;
+  /* Data is unimportant ...*/
+} TREENODE;
+#endif
+
+/* CONTEXT FOR ONE REBALANCING. IT HOLDS WHAT listing1.c
+   KEEPS IN FILE STATICS, SO THAT SEPARATE TREES CAN BE
+   OPTIMIZED AT THE SAME TIME FROM DIFFERENT THREADS, EACH
+   WITH ITS OWN CONTEXT.
+  base      IS THE DUMMY NODE AT THE HEAD OF THE VINE, AS
+            list_base IS AT THE HEAD OF THE LIST.
+  count     IS THE NUMBER OF NODES FOUND IN THE TREE, LEFT
+            FOR THE CALLER AFTER optree_r OR optree_pack
+            RETURNS. */
+typedef struct optree_ctx {
+  TREENODE base;
+  long     count;
+} OPTREE_CTX;
+
+void *optree_r(OPTREE_CTX *, void *);
+void *optree_par(OPTREE_CTX *, void *, int);
+
+/* THE TWO HALVES OF optree_r, FOR CODE THAT BUILDS OR
+   KEEPS ITS OWN VINES: optree_vine FLATTENS THE TREE AT
+   base->right INTO A VINE AND RETURNS ITS LENGTH, AND
+   optree_fold TURNS A VINE OF THAT LENGTH BACK INTO A
+   BALANCED TREE AT base->right. */
+long  optree_vine(TREENODE *);
+void  optree_fold(TREENODE *, long);
+
+/* MODES FOR optree_pack
+  OPTREE_PTRS   left AND right POINT INTO THE NEW ARRAY.
+  OPTREE_INDEX  left AND right ARE NULL; THE CHILDREN OF
+                ELEMENT k ARE ELEMENTS OPTREE_LEFT(k) AND
+                OPTREE_RIGHT(k) WHEN THOSE ARE BELOW count. */
+#define OPTREE_PTRS  0
+#define OPTREE_INDEX 1
+
+#define OPTREE_LEFT(k)  (2 * (k) + 1)
+#define OPTREE_RIGHT(k) (2 * (k) + 2)
+
+void *optree_pack(OPTREE_CTX *, void *, size_t, int);
+
+#endif
@@ -0,0 +1,147 @@
+#include <stddef.h>
+#include "sgtree.h"
+
+static void rebuild (SGTREE *);
+static void raise_to(SGTREE *);
+static long count   (TREENODE *);
+
+/* START AN EMPTY TREE; alpha IS KEPT IN [0.5, 0.8], LOWER
+   MEANING SHALLOWER TREES AND MORE FREQUENT REBUILDS */
+void sgt_init(SGTREE *sgt, SGT_CMP cmp, double alpha)
+{
+  if (alpha < 0.5) alpha = 0.5;
+  if (alpha > 0.8) alpha = 0.8;
+  sgt->root     = NULL;
+  sgt->size     = 0;
+  sgt->max_size = 0;
+  sgt->alpha    = alpha;
+  sgt->cmp      = cmp;
+  sgt->bound    = 0;
+  sgt->next     = 1 / alpha;
+}
+
+/* FIND THE NODE MATCHING key, OR NULL */
+void *sgt_find(SGTREE *sgt, const void *key)
+{
+  TREENODE *node = sgt->root;
+  int c;
+
+  while (node != NULL) {
+    if ((c = sgt->cmp(key, node)) == 0) break;
+    node = (c < 0) ? node->left : node->right;
+  }
+  return((void *) node);
+}
+
+/* INSERT new_node, RETURNING IT, OR THE NODE ALREADY IN
+   THE TREE WITH AN EQUAL KEY (new_node IS THEN NOT ADDED) */
+void *sgt_insert(SGTREE *sgt, void *new_node)
+{
+  TREENODE **link[SGT_MAXDEPTH + 1];
+  TREENODE **p = &sgt->root;
+  TREENODE *node = (TREENODE *) new_node;
+  long size, sub;
+  int depth = 0, c;
+
+  while (*p != NULL) {
+    if ((c = sgt->cmp(new_node, *p)) == 0) return((void *) *p);
+    link[depth++] = p;
+    if (depth == SGT_MAXDEPTH) {
+      /* ONLY IF THE BOUND HAS BEEN BROKEN: START OVER */
+      rebuild(sgt);
+      return(sgt_insert(sgt, new_node));
+    }
+    p = (c < 0) ? &(*p)->left : &(*p)->right;
+  }
+  node->left = node->right = NULL;
+  *p = node;
+  if (++sgt->size > sgt->max_size) {
+    sgt->max_size = sgt->size;
+    raise_to(sgt);
+  }
+  if (depth <= sgt->bound) return(new_node);
+
+  /* TOO DEEP: CLIMB UNTIL A CHILD OUTWEIGHS ITS PARENT */
+  for (sub = 1; depth-- > 0; sub = size) {
+    TREENODE *up = *link[depth];
+    TREENODE *other = (up->left == *p) ? up->right : up->left;
+
+    size = sub + 1 + count(other);
+    if (sub > sgt->alpha * size) {
+      *link[depth] = (TREENODE *) optree_r(&sgt->ctx, up);
+      break;
+    }
+    p = link[depth];
+  }
+  return(new_node);
+}
+
+/* REMOVE AND RETURN THE NODE MATCHING key, OR NULL */
+void *sgt_delete(SGTREE *sgt, const void *key)
+{
+  TREENODE **p = &sgt->root;
+  TREENODE **q;
+  TREENODE *node, *succ;
+  int c;
+
+  while (*p != NULL && (c = sgt->cmp(key, *p)) != 0)
+    p = (c < 0) ? &(*p)->left : &(*p)->right;
+  if ((node = *p) == NULL) return(NULL);
+
+  if (node->left == NULL)
+    *p = node->right;
+  else if (node->right == NULL)
+    *p = node->left;
+  else {
+    /* REPLACE WITH ITS SUCCESSOR, THE LEFTMOST ON THE RIGHT */
+    for (q = &node->right; (*q)->left != NULL; q = &(*q)->left)
+      ;
+    succ = *q;
+    *q = succ->right;
+    succ->left  = node->left;
+    succ->right = node->right;
+    *p = succ;
+  }
+  node->left = node->right = NULL;
+
+  if (--sgt->size < sgt->alpha * sgt->max_size)
+    rebuild(sgt);
+  return((void *) node);
+}
+
+/* REBUILD THE WHOLE TREE AND START COUNTING AGAIN */
+static void rebuild(SGTREE *sgt)
+{
+  sgt->root = (TREENODE *) optree_r(&sgt->ctx, sgt->root);
+  sgt->size = sgt->max_size = sgt->ctx.count;
+  sgt->bound = 0;
+  sgt->next  = 1 / sgt->alpha;
+  raise_to(sgt);
+}
+
+/* BRING bound UP TO floor(log(max_size) / log(1/alpha));
+   next IS THE POWER OF 1/alpha AT WHICH IT GOES UP ONE */
+static void raise_to(SGTREE *sgt)
+{
+  while (sgt->max_size >= sgt->next) {
+    sgt->bound++;
+    sgt->next /= sgt->alpha;
+  }
+}
+
+/* NODES IN A SUBTREE. THE TREE IS NEVER DEEPER THAN
+   SGT_MAXDEPTH, SO A FIXED STACK OF RIGHT CHILDREN DOES */
+static long count(TREENODE *node)
+{
+  TREENODE *stack[SGT_MAXDEPTH + 1];
+  int top = 0;
+  long num = 0;
+
+  while (node != NULL || top > 0) {
+    if (node == NULL) node = stack[--top];
+    num++;
+    if (node->right != NULL) stack[top++] = node->right;
+    node = node->left;
+  }
+  return(num);
+}
@@ -0,0 +1,40 @@
+#ifndef SGTREE_H
+#define SGTREE_H
+
+#include "optree.h"
+
+/* SCAPEGOAT TREE OVER TREENODE: A PLAIN BINARY TREE THAT
+   REBALANCES ITSELF A SUBTREE AT A TIME, WITH NOTHING ADDED
+   TO THE NODES. AN INSERT THAT LANDS DEEPER THAN
+   log(max_size) / log(1/alpha) FINDS THE LOWEST ANCESTOR
+   WITH ONE CHILD HOLDING MORE THAN alpha OF ITS NODES (THE
+   SCAPEGOAT) AND REBUILDS JUST THAT SUBTREE WITH optree_r.
+   A DELETE THAT LEAVES FEWER THAN alpha * max_size NODES
+   REBUILDS THE WHOLE TREE. INSERTS AND DELETES TAKE
+   AMORTIZED O(log n), FINDS O(log n) WORST CASE.
+
+   THE COMPARISON IS CALLED AS cmp(key, node) AND RETURNS
+   <0, 0 OR >0 AS FOR qsort; ON INSERT THE KEY IS THE NEW
+   NODE ITSELF. */
+
+#define SGT_MAXDEPTH 200        /* ENOUGH FOR alpha <= 0.8 */
+
+typedef int (*SGT_CMP)(const void *, const void *);
+
+typedef struct sgtree {
+  TREENODE  *root;
+  long       size;      /* NODES IN THE TREE */
+  long       max_size;  /* MOST SINCE THE LAST FULL REBUILD */
+  double     alpha;
+  int        bound;     /* DEEPEST INSERT ALLOWED */
+  double     next;      /* max_size THAT RAISES bound */
+  SGT_CMP    cmp;
+  OPTREE_CTX ctx;
+} SGTREE;
+
+void  sgt_init  (SGTREE *, SGT_CMP, double);
+void *sgt_find  (SGTREE *, const void *);
+void *sgt_insert(SGTREE *, void *);
+void *sgt_delete(SGTREE *, const void *);
+
+#endif
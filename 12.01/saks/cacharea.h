@@ -0,0 +1,260 @@
+// cacharea.h - an opt-in cached area for shapes, and a collection
+// that keeps its area queries up to date as shapes come and go
+//
+// cached_area<S, B> is shape class S (circle, rectangle, ...,
+// derived from base B, normally shape) with area() computed once,
+// at construction, and returned from then on.  The shape is changed
+// only through modify(), which marks the area dirty; it is then
+// recomputed on the next call, or at once if the shape is in an
+// area_index.
+//
+//	typedef cached_area<circle, shape> cached_circle;
+//	cached_circle c(shape::RED, 2);
+//	c.modify([](circle &s) { s = circle(shape::RED, 3); });
+//
+// area_index<B> holds shapes ordered by area, largest first, so
+// that largest(), total() and top(k) cost O(1), O(1) and O(k)
+// instead of a pass over the collection with a virtual call per
+// shape.  Adding or removing a shape costs O(log n).  A cached
+// shape tells the index when it is modified and takes itself out
+// when it is destroyed; a plain shape is added by its area at the
+// time and must not change while it is in the index.
+
+#ifndef CACHAREA_H
+#define CACHAREA_H
+
+#include <cstddef>
+#include <set>
+#include <unordered_map>
+
+template <class B> class area_index;
+
+template <class S, class B>
+class cached_area : public S
+	{
+public:
+	template <class... A>
+	cached_area(A... a)
+		: S(a...), _area(S::area()), _dirty(false), _index(0) { }
+	cached_area(const cached_area &c)
+		: S(c), _area(c._area), _dirty(c._dirty), _index(0) { }
+	~cached_area();
+	cached_area &operator=(const cached_area &c);
+	double area() const;
+	template <class F> void modify(F f);
+private:
+	mutable double _area;
+	mutable bool _dirty;
+	area_index<B> *_index;
+	friend class area_index<B>;
+	};
+
+template <class B>
+class area_index
+	{
+public:
+	area_index() : _seq(0), _total(0), _removed(0) { }
+	~area_index();
+	void add(const B *s);
+	template <class S> void add(cached_area<S, B> *s);
+	void remove(const B *s);
+	template <class S> void remove(cached_area<S, B> *s);
+	void update(const B *s);
+
+	size_t size() const;
+	const B *largest() const;
+	double total() const;
+	size_t top(const B **out, size_t k) const;
+private:
+	area_index(const area_index &);
+	area_index &operator=(const area_index &);
+
+	// Largest area first; equal areas in the order added
+	struct entry
+		{
+		double area;
+		unsigned long seq;
+		const B *s;
+		bool operator<(const entry &e) const
+			{
+			return area != e.area ? area > e.area : seq < e.seq;
+			}
+		};
+	std::set<entry> _order;
+	std::unordered_map<const B *, entry> _where;
+	std::unordered_map<const B *, void (*)(const B *)> _cached;
+	unsigned long _seq;
+	long double _total;
+	size_t _removed;	// removals since _total was last summed
+	void insert(const B *s, double a, unsigned long seq);
+	unsigned long erase(const B *s);
+	};
+
+template <class S, class B>
+cached_area<S, B>::~cached_area()
+	{
+	if (_index)
+		_index->remove(this);
+	}
+
+template <class S, class B>
+cached_area<S, B> &cached_area<S, B>::operator=(const cached_area &c)
+	{
+	S::operator=(c);
+	_area = c._area;
+	_dirty = c._dirty;
+	if (_index)
+		_index->update(this);
+	return *this;
+	}
+
+template <class S, class B>
+double cached_area<S, B>::area() const
+	{
+	if (_dirty)
+		{
+		_area = S::area();
+		_dirty = false;
+		}
+	return _area;
+	}
+
+template <class S, class B> template <class F>
+void cached_area<S, B>::modify(F f)
+	{
+	f(static_cast<S &>(*this));
+	_dirty = true;
+	if (_index)
+		_index->update(this);
+	}
+
+template <class B>
+area_index<B>::~area_index()
+	{
+	for (auto &c : _cached)
+		c.second(c.first);
+	}
+
+template <class B>
+void area_index<B>::add(const B *s)
+	{
+	if (_where.count(s) == 0)
+		insert(s, s->area(), _seq++);
+	}
+
+template <class B> template <class S>
+void area_index<B>::add(cached_area<S, B> *s)
+	{
+	if (_where.count(s) != 0 || s->_index != 0)
+		return;
+	s->_index = this;
+	_cached[s] = [](const B *p)
+		{
+		const_cast<cached_area<S, B> *>(
+			static_cast<const cached_area<S, B> *>(p))->_index = 0;
+		};
+	insert(s, s->area(), _seq++);
+	}
+
+template <class B>
+void area_index<B>::remove(const B *s)
+	{
+	auto c = _cached.find(s);
+	if (c != _cached.end())
+		{
+		c->second(s);
+		_cached.erase(c);
+		}
+	erase(s);
+	}
+
+template <class B> template <class S>
+void area_index<B>::remove(cached_area<S, B> *s)
+	{
+	remove(static_cast<const B *>(s));
+	}
+
+//
+// Reorder s after its area has changed; it keeps its place among
+// shapes of equal area
+//
+template <class B>
+void area_index<B>::update(const B *s)
+	{
+	if (_where.count(s) != 0)
+		insert(s, s->area(), erase(s));
+	}
+
+template <class B>
+inline size_t area_index<B>::size() const
+	{
+	return _order.size();
+	}
+
+//
+// As largest() in largest.cpp: the first shape with the largest
+// positive area, or null
+//
+template <class B>
+const B *area_index<B>::largest() const
+	{
+	if (_order.empty() || !(_order.begin()->area > 0))
+		return 0;
+	return _order.begin()->s;
+	}
+
+//
+// The running sum.  Each removal subtracts from it, which lets
+// rounding error build up, so erase() sums it afresh, smallest
+// area first, once removals outnumber the shapes: still O(1)
+// amortized, and never more than about 2n roundings off
+//
+template <class B>
+inline double area_index<B>::total() const
+	{
+	return (double)_total;
+	}
+
+//
+// The k largest shapes, largest first, into out[]; returns how
+// many there were
+//
+template <class B>
+size_t area_index<B>::top(const B **out, size_t k) const
+	{
+	size_t n = 0;
+	for (auto i = _order.begin(); n < k && i != _order.end(); ++i)
+		out[n++] = i->s;
+	return n;
+	}
+
+template <class B>
+void area_index<B>::insert(const B *s, double a, unsigned long seq)
+	{
+	entry e = { a, seq, s };
+	_order.insert(e);
+	_where[s] = e;
+	_total += a;
+	}
+
+template <class B>
+unsigned long area_index<B>::erase(const B *s)
+	{
+	auto w = _where.find(s);
+	if (w == _where.end())
+		return 0;
+	unsigned long seq = w->second.seq;
+	_total -= w->second.area;
+	_order.erase(w->second);
+	_where.erase(w);
+	if (++_removed > _order.size())
+		{
+		_total = 0;
+		for (auto i = _order.rbegin(); i != _order.rend(); ++i)
+			_total += i->area;
+		_removed = 0;
+		}
+	return seq;
+	}
+
+#endif
@@ -0,0 +1,99 @@
+// shapeset.cpp - member functions of shape_set
+//
+// With -fopenmp-simd (or -fopenmp) each loop runs as many lanes as
+// the target has.  Circle areas are computed as circle::area
+// computes them, pi * r * r, so the results agree to the bit.
+
+#include "shapeset.h"
+
+#include <cmath>
+
+static const double pi = 3.1415926;     // as in circle::area
+
+size_t shape_set::add_circle(palette c, double r)
+	{
+	_radius.push_back(r);
+	_ccolor.push_back((unsigned char)c);
+	return _radius.size() - 1;
+	}
+
+size_t shape_set::add_rectangle(palette c, double h, double w)
+	{
+	_height.push_back(h);
+	_width.push_back(w);
+	_rcolor.push_back((unsigned char)c);
+	return _height.size() - 1;
+	}
+
+shape_set::palette shape_set::color(ref s) const
+	{
+	return palette(s.k == CIRCLE ? _ccolor[s.i] : _rcolor[s.i]);
+	}
+
+double shape_set::area(ref s) const
+	{
+	if (s.k == CIRCLE)
+		return pi * _radius[s.i] * _radius[s.i];
+	if (s.k == RECTANGLE)
+		return _height[s.i] * _width[s.i];
+	return 0;
+	}
+
+//
+// The area of every circle into ca[0..circles()-1], and of every
+// rectangle into ra[0..rectangles()-1].
+//
+void shape_set::areas(double *ca, double *ra) const
+	{
+	const double *r = _radius.data();
+	const double *h = _height.data();
+	const double *w = _width.data();
+	size_t n = circles();
+#pragma omp simd
+	for (size_t i = 0; i < n; ++i)
+		ca[i] = pi * r[i] * r[i];
+	n = rectangles();
+#pragma omp simd
+	for (size_t i = 0; i < n; ++i)
+		ra[i] = h[i] * w[i];
+	}
+
+//
+// The shape with the largest area, as largest() in largest.cpp
+// finds it: the area must be positive, and a tie goes to the
+// first shape, circles counting as before rectangles.  Each kind
+// takes a vectorized max reduction, then a scan for the first
+// shape that reaches the max.  The largest circle is the one with
+// the largest |r|, since pi * r * r rounds monotonically in it.
+// Returns a ref of kind NONE if no area is positive.
+//
+shape_set::ref shape_set::largest() const
+	{
+	const double *r = _radius.data();
+	const double *h = _height.data();
+	const double *w = _width.data();
+	size_t nc = circles(), nr = rectangles();
+	double rmax = 0, cm, rm = 0;
+#pragma omp simd reduction(max:rmax)
+	for (size_t i = 0; i < nc; ++i)
+		rmax = rmax > std::fabs(r[i]) ? rmax : std::fabs(r[i]);
+	cm = pi * rmax * rmax;
+#pragma omp simd reduction(max:rm)
+	for (size_t i = 0; i < nr; ++i)
+		rm = rm > h[i] * w[i] ? rm : h[i] * w[i];
+
+	ref s = { NONE, 0 };
+	if (cm > 0 && cm >= rm)
+		{
+		s.k = CIRCLE;
+		while (std::fabs(r[s.i]) != rmax)
+			++s.i;
+		}
+	else if (rm > 0)
+		{
+		s.k = RECTANGLE;
+		while (h[s.i] * w[s.i] != rm)
+			++s.i;
+		}
+	return s;
+	}
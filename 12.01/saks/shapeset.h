@@ -0,0 +1,74 @@
+// shapeset.h - a collection of circles and rectangles stored by type
+//
+// Where largest() in largest.cpp calls the virtual area() through
+// an array of pointers to objects scattered on the heap, a
+// shape_set keeps each kind of shape in its own arrays, one array
+// per member (radius[], height[] and width[]).  The batch queries
+// then run one loop per kind, with no indirect calls, over
+// contiguous doubles the compiler can vectorize.
+
+#ifndef SHAPESET_H
+#define SHAPESET_H
+
+#include <cstddef>
+#include <vector>
+
+class shape_set
+	{
+public:
+	enum palette { BLUE, GREEN, RED };      // as in class shape
+	enum kind { NONE, CIRCLE, RECTANGLE };
+
+	// A shape in the set: its kind and its index among that kind
+	struct ref
+		{
+		kind k;
+		size_t i;
+		};
+
+	size_t add_circle(palette c, double r);
+	size_t add_rectangle(palette c, double h, double w);
+
+	size_t circles() const;
+	size_t rectangles() const;
+	double radius(size_t i) const;
+	double height(size_t i) const;
+	double width(size_t i) const;
+	palette color(ref s) const;
+	double area(ref s) const;
+
+	void areas(double *ca, double *ra) const;
+	ref largest() const;
+private:
+	std::vector<double> _radius;
+	std::vector<unsigned char> _ccolor;
+	std::vector<double> _height, _width;
+	std::vector<unsigned char> _rcolor;
+	};
+
+inline size_t shape_set::circles() const
+	{
+	return _radius.size();
+	}
+
+inline size_t shape_set::rectangles() const
+	{
+	return _height.size();
+	}
+
+inline double shape_set::radius(size_t i) const
+	{
+	return _radius[i];
+	}
+
+inline double shape_set::height(size_t i) const
+	{
+	return _height[i];
+	}
+
+inline double shape_set::width(size_t i) const
+	{
+	return _width[i];
+	}
+
+#endif
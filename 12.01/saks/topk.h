@@ -0,0 +1,165 @@
+// topk.h - parallel largest() and top-k over an array of shapes
+//
+// largest() in largest.cpp scans the array on one thread and keeps
+// one pointer.  top_k() and par_largest() split the array into one
+// range per thread; each thread keeps the k best elements of its
+// range in a bounded heap, and the heaps are merged when the
+// threads are done.  The selection metric is any callable on the
+// element type (area, by default), so the same code ranks by
+// perimeter, by a color, or by anything else a caller can compute
+// from a shape.
+//
+// Ties go to the element that comes first in the array, as in
+// largest.cpp, whatever the number of threads.  Unlike largest.cpp,
+// elements whose metric is not positive still count.  An exception
+// thrown by the metric in any thread is rethrown to the caller.
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace topk_detail
+	{
+	template <class V>
+	struct cand
+		{
+		V v;
+		size_t i;
+		};
+
+	// a ranks ahead of b: larger metric, then earlier in the array
+	template <class V>
+	inline bool ahead(const cand<V> &a, const cand<V> &b)
+		{
+		return b.v < a.v || (!(a.v < b.v) && a.i < b.i);
+		}
+
+	// The k best of sa[lo..hi) into h, a heap with the worst first
+	template <class T, class M, class V>
+	void scan(const T *const sa[], size_t lo, size_t hi, size_t k, M &m,
+		std::vector<cand<V> > &h)
+		{
+		h.reserve(std::min(k, hi - lo));
+		for (size_t i = lo; i < hi; ++i)
+			{
+			cand<V> c = { m(*sa[i]), i };
+			if (h.size() < k)
+				{
+				h.push_back(c);
+				std::push_heap(h.begin(), h.end(), ahead<V>);
+				}
+			else if (ahead(c, h.front()))
+				{
+				std::pop_heap(h.begin(), h.end(), ahead<V>);
+				h.back() = c;
+				std::push_heap(h.begin(), h.end(), ahead<V>);
+				}
+			}
+		}
+
+	struct by_area
+		{
+		template <class T>
+		double operator()(const T &s) const
+			{
+			return s.area();
+			}
+		};
+	}
+
+//
+// The k best of sa[0..n-1] by metric m, best first, into out[];
+// returns how many there were (k, or n if that is smaller).
+// threads == 0 means one per hardware thread.  Ranges shorter than
+// min_range are not worth a thread of their own.
+//
+template <class T, class M = topk_detail::by_area>
+size_t top_k(const T *const sa[], size_t n, const T **out, size_t k,
+	M m = M(), unsigned threads = 0, size_t min_range = 1 << 16)
+	{
+	// by value, should m return a reference
+	typedef typename std::decay<decltype(m(*sa[0]))>::type V;
+	typedef topk_detail::cand<V> cand;
+	if (k == 0 || n == 0)
+		return 0;
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	size_t most = (n + min_range - 1) / min_range;
+	if (threads > most)
+		threads = unsigned(most);
+
+	// Each thread gets its own copy of m, made here before any
+	// thread starts, as this thread goes on using m itself
+	std::vector<std::vector<cand> > heap(threads);
+	std::vector<std::exception_ptr> err(threads);
+	std::vector<M> mt(threads - 1, m);
+	std::vector<std::thread> pool;
+	try
+		{
+		for (unsigned t = 1; t < threads; ++t)
+			pool.emplace_back([&, t]
+				{
+				try
+					{
+					topk_detail::scan(sa, n * t / threads,
+						n * (t + 1) / threads, k, mt[t - 1],
+						heap[t]);
+					}
+				catch (...)
+					{
+					err[t] = std::current_exception();
+					}
+				});
+		}
+	catch (...)
+		{
+		// a joinable thread must not be destroyed
+		for (std::thread &th : pool)
+			th.join();
+		throw;
+		}
+	try
+		{
+		topk_detail::scan(sa, 0, n / threads, k, m, heap[0]);
+		}
+	catch (...)
+		{
+		err[0] = std::current_exception();
+		}
+	for (std::thread &th : pool)
+		th.join();
+	for (std::exception_ptr &e : err)
+		if (e)
+			std::rethrow_exception(e);
+
+	// Merge: at most threads * k candidates
+	std::vector<cand> all;
+	for (std::vector<cand> &h : heap)
+		all.insert(all.end(), h.begin(), h.end());
+	size_t r = std::min(k, all.size());
+	std::partial_sort(all.begin(), all.begin() + r, all.end(),
+		topk_detail::ahead<V>);
+	for (size_t i = 0; i < r; ++i)
+		out[i] = sa[all[i].i];
+	return r;
+	}
+
+//
+// The first element with the best metric, or null if n == 0
+//
+template <class T, class M = topk_detail::by_area>
+const T *par_largest(const T *const sa[], size_t n, M m = M(),
+	unsigned threads = 0)
+	{
+	const T *s = 0;
+	top_k(sa, n, &s, 1, m, threads);
+	return s;
+	}
+
+#endif